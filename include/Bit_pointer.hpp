@@ -12,6 +12,8 @@
 #include <iterator>
 #include <limits>
 #include <cstdint>
+#include <cstring>
+#include <bit>
 #include <algorithm>
 
 // Bit<T>, Bit_pointer<T> and Bit_range<T> (where T is a random access iterator or pointer referring
@@ -104,6 +106,31 @@
 //      iterators from and to. Updates the Bit_range start to point to the next unassigned Bit_range.
 //      If T_iter::value type has insufficient precision to store the extracted value, this value is clamped
 //      to the maximum representable value (or minimum value in case T_iter::value is signed and underflow occurs).
+//
+// In addition, Bit_writer and Bit_reader provide strictly sequential access to a little-endian
+// bitstream of std::uint8_t through a 64-bit shift-register accumulator. They give up the random
+// access and iterator interface of Bit_pointer/Bit_range, but in return the accumulator lives in a
+// register across a packing or unpacking loop, and memory is only touched a word at a time:
+//
+//  Bit_writer(std::uint8_t* out)
+//      Constructs a writer appending bits at 'out', which must be byte-aligned; the bytes to be
+//      written must be readable and writable up to the flushed end of the stream.
+//  void Bit_writer::write(std::uint64_t value, int bits)
+//      Appends the 'bits' least significant bits of 'value' to the stream.
+//  std::size_t Bit_writer::bits_written()
+//      Number of bits appended so far.
+//  void Bit_writer::flush()
+//      Writes out the bits still held in the accumulator, zero-padding the last byte. No further
+//      write() is allowed afterwards.
+//  Bit_reader(std::uint8_t const* begin, std::uint8_t const* end)
+//      Constructs a reader consuming bits from 'begin'; never loads at or beyond 'end', bits past
+//      'end' read as zero.
+//  std::uint64_t Bit_reader::read(int bits)
+//      Consumes and returns the next 'bits' bits (at most 56).
+//  void Bit_reader::skip(std::size_t bits)
+//      Advances the stream position without extracting, by any distance.
+//  std::size_t Bit_reader::bit_position()
+//      Number of bits consumed so far.
 
 namespace jpa {
 
@@ -796,6 +823,216 @@ private:
     std::size_t const d_size;
 };
 
+/*************************************************************************/
+
+// Unaligned little-endian word access, independent of the host byte order. On little-endian
+// machines each compiles to a single unaligned MOV (memcpy of a constant size is folded away);
+// big-endian machines assemble the bytes explicitly, so the bitstream format stays portable.
+
+/**
+ * @brief Loads eight bytes at 'p' as a little-endian 64-bit value.
+ *
+ * @param p The address to load from; no alignment is required.
+ * @return The little-endian interpretation of the eight bytes at 'p'.
+ */
+inline std::uint64_t read64le(std::uint8_t const* p) noexcept {
+    if constexpr (std::endian::native == std::endian::little) {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    else {
+        std::uint64_t v = 0;
+        for (int i = 0; i != 8; ++i)
+            v |= std::uint64_t(p[i]) << (8 * i);
+        return v;
+    }
+}
+
+/**
+ * @brief Stores 'v' as eight little-endian bytes at 'p'.
+ *
+ * @param p The address to store to; no alignment is required.
+ * @param v The value to store.
+ */
+inline void write64le(std::uint8_t* p, std::uint64_t const v) noexcept {
+    if constexpr (std::endian::native == std::endian::little)
+        std::memcpy(p, &v, sizeof(v));
+    else
+        for (int i = 0; i != 8; ++i)
+            p[i] = std::uint8_t(v >> (8 * i));
+}
+
+/**
+ * @brief Stores 'v' as four little-endian bytes at 'p'.
+ *
+ * @param p The address to store to; no alignment is required.
+ * @param v The value to store.
+ */
+inline void write32le(std::uint8_t* p, std::uint32_t const v) noexcept {
+    if constexpr (std::endian::native == std::endian::little)
+        std::memcpy(p, &v, sizeof(v));
+    else
+        for (int i = 0; i != 4; ++i)
+            p[i] = std::uint8_t(v >> (8 * i));
+}
+
+/**
+ * @brief Bit_writer appends variable-width values to a little-endian bitstream through a 64-bit
+ * shift-register accumulator. Unlike Bit_range, the pending bits stay in a register across a
+ * packing loop and memory is only touched to retire completed 32-bit words, so the compiler can
+ * keep the whole inner loop free of byte-granular loads and stores.
+ */
+class Bit_writer {
+public:
+    /**
+     * @brief Constructs a Bit_writer appending bits at 'out', which must be byte-aligned.
+     *
+     * @param out Pointer to the first byte to be written.
+     */
+    explicit Bit_writer(std::uint8_t* out) noexcept : d_begin(out), d_next(out) {}
+
+    /**
+     * @brief Appends the 'bits' least significant bits of 'value' to the stream; higher bits of
+     * 'value' are ignored.
+     *
+     * @param value The value to append.
+     * @param bits The number of bits of 'value' to append (at most 64).
+     */
+    void write(std::uint64_t value, int bits) noexcept {
+        if (bits > 32) {
+            write(value & 0xffffffff, 32);
+            value >>= 32;
+            bits -= 32;
+        }
+        d_buf |= (value & ((std::uint64_t(1) << bits) - 1)) << d_count;
+        d_count += bits;
+        if (d_count >= 32) { // retire the completed low word, keeping the accumulator below 64 bits
+            write32le(d_next, std::uint32_t(d_buf));
+            d_next += 4;
+            d_buf >>= 32;
+            d_count -= 32;
+        }
+    }
+
+    /**
+     * @brief Returns the number of bits appended so far.
+     *
+     * @return The number of bits appended so far.
+     */
+    std::size_t const bits_written() const noexcept {
+        return std::size_t(d_next - d_begin) * 8 + std::size_t(d_count);
+    }
+
+    /**
+     * @brief Writes out the bits still held in the accumulator, zero-padding the last byte. No
+     * further write() is allowed afterwards.
+     */
+    void flush() noexcept {
+        for (; d_count > 0; d_count -= 8, d_buf >>= 8)
+            *d_next++ = std::uint8_t(d_buf);
+        d_count = 0;
+        d_buf = 0;
+    }
+
+private:
+    std::uint8_t* const d_begin;
+    std::uint8_t* d_next;
+    std::uint64_t d_buf = 0;
+    int d_count = 0;
+};
+
+/*************************************************************************/
+
+/**
+ * @brief Bit_reader consumes variable-width values from a little-endian bitstream through a 64-bit
+ * shift-register accumulator, refilling it a word at a time. The counterpart of Bit_writer: strictly
+ * sequential, but the pending bits stay in a register across an unpacking loop. The reader never
+ * loads at or beyond the 'end' it was constructed with; bits past 'end' read as zero.
+ */
+class Bit_reader {
+public:
+    /**
+     * @brief Constructs a Bit_reader consuming bits from 'begin', which must be byte-aligned.
+     *
+     * @param begin Pointer to the first byte of the stream.
+     * @param end Pointer just beyond the last readable byte; loads stop short of it.
+     */
+    Bit_reader(std::uint8_t const* begin, std::uint8_t const* end) noexcept :
+        d_begin(begin),
+        d_end(end),
+        d_next(begin) {}
+
+    /**
+     * @brief Consumes and returns the next 'bits' bits of the stream.
+     *
+     * @param bits The number of bits to extract (at most 56).
+     * @return The extracted bits as an unsigned value.
+     */
+    std::uint64_t read(int bits) noexcept {
+        if (d_count < bits)
+            f_refill();
+        std::uint64_t const value = d_buf & ((std::uint64_t(1) << bits) - 1);
+        d_buf >>= bits;
+        d_count -= bits;
+        return value;
+    }
+
+    /**
+     * @brief Advances the stream position by 'bits' without extracting, by any distance.
+     *
+     * @param bits The number of bits to skip.
+     */
+    void skip(std::size_t bits) noexcept {
+        std::size_t const pos = bit_position() + bits;
+        d_next = d_begin + (pos >> 3);
+        d_buf = 0;
+        d_count = -int(pos & 7); // the sub-byte remainder is discarded by the next refill
+    }
+
+    /**
+     * @brief Returns the number of bits consumed so far.
+     *
+     * @return The number of bits consumed so far.
+     */
+    std::size_t const bit_position() const noexcept {
+        return std::size_t(d_next - d_begin) * 8 - std::size_t(d_count);
+    }
+
+private:
+    void f_refill() noexcept {
+        if (d_count < 0) { // skip() left a sub-byte remainder to discard
+            int const rem = -d_count;
+            d_count = 0;
+            f_refill();
+            d_buf >>= rem;
+            d_count -= rem;
+            return;
+        }
+        if (d_end - d_next >= 8) {
+            // Top the accumulator up to at least 57 bits with a single unaligned load,
+            // consuming only the whole bytes that fit beside the bits still pending.
+            d_buf |= read64le(d_next) << d_count;
+            int const take = (64 - d_count) >> 3;
+            d_next += take;
+            d_count += take * 8;
+        }
+        else
+            // At the end of the stream the accumulator simply stops refilling: read() then
+            // extracts zero bits and d_count goes negative, which keeps bit_position() exact.
+            while (d_count <= 56 && d_next != d_end) {
+                d_buf |= std::uint64_t(*d_next++) << d_count;
+                d_count += 8;
+            }
+    }
+
+    std::uint8_t const* const d_begin;
+    std::uint8_t const* const d_end;
+    std::uint8_t const* d_next;
+    std::uint64_t d_buf = 0;
+    int d_count = 0;
+};
+
 }
 
 
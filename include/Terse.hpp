@@ -11,12 +11,25 @@
 
 #include <fstream>
 #include <vector>
+#include <array>
+#include <bit>
 #include <charconv>
 #include <cassert>
 #include <cmath>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <thread>
+#include <atomic>
+#include <string_view>
 #include "Bit_pointer.hpp"
 #include "XML_element.hpp"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JPA_TERSE_X86 1
+#include <immintrin.h>
+#endif
+
 // Terse<T> allows efficient and fast compression of integral diffraction data and other integral greyscale
 // data into a Terse object that can be decoded by the member function Terse<T>::prolix(iterator). The
 // prolix(iterator) member function decompresses the data starting at the location defined by 'iterator'
@@ -157,6 +170,267 @@
 
 namespace jpa {
 
+// SIMD kernels used by Terse on x86-64. Each kernel is compiled with its own target
+// attribute and selected at run time, so the header builds without special compiler flags
+// and a single binary runs on any CPU.
+namespace terse_detail {
+
+#ifdef JPA_TERSE_X86
+inline bool have_avx2() noexcept {
+    static bool const r = __builtin_cpu_supports("avx2");
+    return r;
+}
+
+// OR-reduction of |v| over a block of 32-bit values: 8 lanes per OR instead of
+// 8 serially dependent scalar ORs. The tail is handled with a masked load.
+// With Copy set, the raw values are also written to 'dst' from the registers
+// already holding them, so the caller never reads the input a second time.
+template <bool Signed, bool Copy = false>
+__attribute__((target("avx2")))
+inline std::uint32_t or_abs_block32_avx2(std::int32_t const* p, std::size_t n, std::int32_t* dst = nullptr) noexcept {
+    __m256i acc = _mm256_setzero_si256();
+    for (; n >= 8; n -= 8, p += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+        if constexpr (Copy) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), v);
+            dst += 8;
+        }
+        acc = _mm256_or_si256(acc, Signed ? _mm256_abs_epi32(v) : v);
+    }
+    if (n) {
+        alignas(32) static constexpr std::int32_t iota[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+        __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(int(n)), _mm256_load_si256(reinterpret_cast<__m256i const*>(iota)));
+        __m256i v = _mm256_maskload_epi32(p, mask);
+        if constexpr (Copy)
+            _mm256_maskstore_epi32(dst, mask, v);
+        acc = _mm256_or_si256(acc, Signed ? _mm256_abs_epi32(v) : v);
+    }
+    __m128i r = _mm_or_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    r = _mm_or_si128(r, _mm_shuffle_epi32(r, 0b01001110));
+    r = _mm_or_si128(r, _mm_shuffle_epi32(r, 0b10110001));
+    return std::uint32_t(_mm_cvtsi128_si32(r));
+}
+
+// Same reduction for 16-bit values; the sub-vector tail is OR-ed in scalarly.
+template <bool Signed, bool Copy = false>
+__attribute__((target("avx2")))
+inline std::uint16_t or_abs_block16_avx2(std::int16_t const* p, std::size_t n, std::int16_t* dst = nullptr) noexcept {
+    __m256i acc = _mm256_setzero_si256();
+    for (; n >= 16; n -= 16, p += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+        if constexpr (Copy) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), v);
+            dst += 16;
+        }
+        acc = _mm256_or_si256(acc, Signed ? _mm256_abs_epi16(v) : v);
+    }
+    __m128i r = _mm_or_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    r = _mm_or_si128(r, _mm_shuffle_epi32(r, 0b01001110));
+    r = _mm_or_si128(r, _mm_shuffle_epi32(r, 0b10110001));
+    std::uint16_t result = std::uint16_t(_mm_cvtsi128_si32(r) | (_mm_cvtsi128_si32(r) >> 16));
+    for (; n; --n, ++p) {
+        std::int16_t v = *p;
+        if constexpr (Copy)
+            *dst++ = v;
+        if constexpr (Signed) {
+            std::int16_t const s = std::int16_t(v >> 15);
+            v = std::int16_t((v ^ s) - s);
+        }
+        result |= std::uint16_t(v);
+    }
+    return result;
+}
+// Zero-fills a buffer with non-temporal stores, bypassing the cache. For output
+// regions larger than L2 the write-allocate traffic of a cached memset doubles the
+// memory bandwidth; streaming stores avoid it. SSE2 is part of the x86-64 baseline,
+// so this needs no runtime dispatch.
+inline void stream_zero_bytes(void* dst, std::size_t bytes) noexcept {
+    unsigned char* p = static_cast<unsigned char*>(dst);
+    for (; bytes && (reinterpret_cast<std::uintptr_t>(p) & 15); --bytes)
+        *p++ = 0;
+    __m128i const zero = _mm_setzero_si128();
+    for (; bytes >= 16; bytes -= 16, p += 16)
+        _mm_stream_si128(reinterpret_cast<__m128i*>(p), zero);
+    _mm_sfence();
+    std::memset(p, 0, bytes);
+}
+
+inline bool have_avx512_unpack() noexcept {
+    static bool const r = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512vbmi");
+    return r;
+}
+
+// Unpacks up to 16 values of B bits each, starting at bit 'src_bit' of 'src', into
+// 16- or 32-bit destination lanes. Each value's four source bytes are gathered with a
+// single VPERMB, then shifted to bit 0 with a per-lane variable shift and masked:
+// about four instructions per 16 values instead of per-value bit-pointer arithmetic.
+// The caller must guarantee that 64 bytes can be read from 'src'.
+template <int B, typename OutT>
+__attribute__((target("avx512f,avx512bw,avx512vl,avx512vbmi")))
+inline void unpack_block_avx512(std::uint8_t const* src, int src_bit, OutT* dst, unsigned n) noexcept {
+    static_assert(B >= 1 && B <= 16);
+    static_assert(sizeof(OutT) == 2 || sizeof(OutT) == 4);
+    __m512i const iota = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i const start = _mm512_add_epi32(_mm512_mullo_epi32(iota, _mm512_set1_epi32(B)), _mm512_set1_epi32(src_bit));
+    __m512i const byte = _mm512_srli_epi32(start, 3);
+    __m512i const rel = _mm512_and_si512(start, _mm512_set1_epi32(7));
+    __m512i const idx = _mm512_add_epi32(_mm512_mullo_epi32(byte, _mm512_set1_epi32(0x01010101)), _mm512_set1_epi32(0x03020100));
+    __m512i v = _mm512_permutexvar_epi8(idx, _mm512_loadu_si512(src));
+    v = _mm512_srlv_epi32(v, rel);
+    v = _mm512_and_si512(v, _mm512_set1_epi32((1 << B) - 1));
+    if constexpr (std::is_signed_v<OutT>)
+        // Branchless sign extension: shift the field's sign bit to bit 31, then shift
+        // back arithmetically. Truncating to 16-bit lanes afterwards keeps the sign.
+        v = _mm512_srai_epi32(_mm512_slli_epi32(v, 32 - B), 32 - B);
+    __mmask16 const m = __mmask16((1u << n) - 1);
+    if constexpr (sizeof(OutT) == 4)
+        _mm512_mask_storeu_epi32(dst, m, v);
+    else
+        _mm256_mask_storeu_epi16(dst, m, _mm512_cvtepi32_epi16(v));
+}
+
+// Width-indexed dispatch table of unpack kernels, one specialization per width.
+template <typename OutT>
+struct unpack_table_avx512 {
+    using fn = void (*)(std::uint8_t const*, int, OutT*, unsigned);
+    static constexpr std::array<fn, 17> value = {
+        nullptr,
+        &unpack_block_avx512<1, OutT>,  &unpack_block_avx512<2, OutT>,  &unpack_block_avx512<3, OutT>,
+        &unpack_block_avx512<4, OutT>,  &unpack_block_avx512<5, OutT>,  &unpack_block_avx512<6, OutT>,
+        &unpack_block_avx512<7, OutT>,  &unpack_block_avx512<8, OutT>,  &unpack_block_avx512<9, OutT>,
+        &unpack_block_avx512<10, OutT>, &unpack_block_avx512<11, OutT>, &unpack_block_avx512<12, OutT>,
+        &unpack_block_avx512<13, OutT>, &unpack_block_avx512<14, OutT>, &unpack_block_avx512<15, OutT>,
+        &unpack_block_avx512<16, OutT>};
+};
+
+// Unpacks as many of the n values as the AVX-512 kernels can reach without loading
+// past 'bufend'; returns the number of values written. The caller decodes the rest.
+template <typename OutT>
+inline std::size_t unpack_fixed_avx512(std::uint8_t const* base, std::size_t bitpos, int bits,
+                                       OutT* dst, std::size_t n, std::uint8_t const* bufend) noexcept {
+    if (bits < 1 || bits > 16) // reached through unpack_dispatch, so CPU support is already known
+        return 0;
+    auto const fn = unpack_table_avx512<OutT>::value[bits];
+    std::size_t done = 0;
+    while (done != n) {
+        std::uint8_t const* const src = base + (bitpos >> 3);
+        if (src + 64 > bufend)
+            break;
+        unsigned const chunk = unsigned(std::min<std::size_t>(16, n - done));
+        fn(src, int(bitpos & 7), dst + done, chunk);
+        done += chunk;
+        bitpos += std::size_t(chunk) * bits;
+    }
+    return done;
+}
+#endif // JPA_TERSE_X86
+
+// Fallback unpack kernel: unpacks nothing, leaving every value to the caller's scalar loop.
+template <typename OutT>
+inline std::size_t unpack_none(std::uint8_t const*, std::size_t, int, OutT*, std::size_t,
+                               std::uint8_t const*) noexcept {
+    return 0;
+}
+
+// One-time runtime dispatch for the block-unpack kernels. The best kernel the running CPU
+// supports is resolved exactly once per process into 'value'; prolix() reads the pointer once
+// per frame, so the per-block code contains no CPU feature tests at all, and the same binary
+// runs on any target. Non-x86 machines (and output types without a vector kernel) resolve to
+// unpack_none, i.e. the portable 64-bit scalar path.
+template <typename OutT>
+struct unpack_dispatch {
+    using fn = std::size_t (*)(std::uint8_t const*, std::size_t, int, OutT*, std::size_t,
+                               std::uint8_t const*);
+    static fn f_resolve() noexcept {
+#ifdef JPA_TERSE_X86
+        if constexpr (sizeof(OutT) == 2 || sizeof(OutT) == 4)
+            if (have_avx512_unpack())
+                return &unpack_fixed_avx512<OutT>;
+        // No AVX2 tier: without the byte-granular VPERMB gather, an AVX2 unpack needs
+        // cross-lane shuffles per value and does not beat the 64-bit scalar path.
+#endif
+        return &unpack_none<OutT>;
+    }
+    static inline fn const value = f_resolve();
+};
+
+// OR of |v| over one block, as an unsigned value of the same width. Feeding the
+// reduced scalar into the bit-width computation gives the block's significant bits.
+template <typename T> requires std::is_integral_v<T>
+inline std::make_unsigned_t<T> setbits_of_block(T const* p, std::size_t n) noexcept {
+#ifdef JPA_TERSE_X86
+    if constexpr (sizeof(T) == 4) {
+        if (have_avx2())
+            return std::make_unsigned_t<T>(or_abs_block32_avx2<std::is_signed_v<T>>(reinterpret_cast<std::int32_t const*>(p), n));
+    }
+    else if constexpr (sizeof(T) == 2) {
+        if (have_avx2())
+            return std::make_unsigned_t<T>(or_abs_block16_avx2<std::is_signed_v<T>>(reinterpret_cast<std::int16_t const*>(p), n));
+    }
+#endif
+    std::make_unsigned_t<T> acc = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        auto u = std::make_unsigned_t<T>(p[i]);
+        if constexpr (std::is_signed_v<T>) {
+            // Branchless |v|, done in the unsigned type so INT_MIN wraps instead of overflowing.
+            auto const s = std::make_unsigned_t<T>(p[i] >> (sizeof(T) * 8 - 1));
+            u = (u ^ s) - s;
+        }
+        acc |= u;
+    }
+    return acc;
+}
+
+// As setbits_of_block, but also copies the block into 'dst' during the same pass. The
+// encoder emits the payload from the block-sized copy, which is still in registers or
+// L1 from this pass, instead of issuing a second stream of loads from the input array.
+template <typename T> requires std::is_integral_v<T>
+inline std::make_unsigned_t<T> setbits_of_block_copy(T const* p, std::size_t n, T* dst) noexcept {
+#ifdef JPA_TERSE_X86
+    if constexpr (sizeof(T) == 4) {
+        if (have_avx2())
+            return std::make_unsigned_t<T>(or_abs_block32_avx2<std::is_signed_v<T>, true>(
+                reinterpret_cast<std::int32_t const*>(p), n, reinterpret_cast<std::int32_t*>(dst)));
+    }
+    else if constexpr (sizeof(T) == 2) {
+        if (have_avx2())
+            return std::make_unsigned_t<T>(or_abs_block16_avx2<std::is_signed_v<T>, true>(
+                reinterpret_cast<std::int16_t const*>(p), n, reinterpret_cast<std::int16_t*>(dst)));
+    }
+#endif
+    std::make_unsigned_t<T> acc = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        T const v = dst[i] = p[i];
+        auto u = std::make_unsigned_t<T>(v);
+        if constexpr (std::is_signed_v<T>) {
+            // Branchless |v|, done in the unsigned type so INT_MIN wraps instead of overflowing.
+            auto const s = std::make_unsigned_t<T>(v >> (sizeof(T) * 8 - 1));
+            u = (u ^ s) - s;
+        }
+        acc |= u;
+    }
+    return acc;
+}
+
+// An allocator that leaves new elements default-initialized — untouched, for std::uint8_t —
+// instead of value-initialized. Growing the compression buffer through it skips the memset
+// of a scratch region that the Bit_writer overwrites in full anyway.
+template <typename T>
+struct default_init_allocator : std::allocator<T> {
+    template <typename U> struct rebind {using other = default_init_allocator<U>;};
+    template <typename U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new (static_cast<void*>(p)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+} // end namespace terse_detail
+
 /**
  * @class Terse
  * @brief Terse<T> allows efficient and fast compression of integral diffraction data and other integral greyscale data.
@@ -302,6 +576,70 @@ public:
         f_compress(data);
     }
 
+    /**
+     * @brief Adds a stack of frames to the Terse object, compressing the frames in parallel.
+     *
+     * Each frame is compressed into its own bitstream (one parallel task per frame, since the
+     * frames are mutually independent), and the bitstreams are then concatenated in frame order.
+     * The result is identical to calling push_back() once per frame. All frames must have the
+     * same size as any frame already in the Terse object.
+     *
+     * @tparam T The integral value type of the frames.
+     * @param frames The frames to append, each a contiguous view of size() values.
+     */
+    template <typename T> requires std::is_integral_v<T>
+    void push_back_frames(std::vector<std::span<T const>> const& frames) {
+        if (frames.empty())
+            return;
+        if (number_of_frames() == 0) {
+            d_size = frames.front().size();
+            d_signed = std::is_signed_v<T>;
+        }
+        else
+            assert(d_signed == std::is_signed_v<T>);
+        for ([[maybe_unused]] auto const& frame : frames)
+            assert(frame.size() == size()); // each frame of a multi-Terse object must have the same size
+        std::vector<decltype(d_terse_data)> streams(frames.size());
+        std::vector<std::size_t> stream_bits(frames.size());
+        std::vector<unsigned> stream_prolix_bits(frames.size());
+        auto const compress_one = [&](std::size_t const i) {
+            Terse part(frames[i].data(), frames[i].size(), d_block);
+            part.d_terse_data.resize(part.f_terse_bytes());
+            streams[i] = std::move(part.d_terse_data);
+            stream_bits[i] = part.d_bit_cursor;
+            stream_prolix_bits[i] = part.d_prolix_bits;
+        };
+        std::size_t const workers = std::min<std::size_t>(frames.size(), std::max(1u, std::thread::hardware_concurrency()));
+        if (workers < 2)
+            for (std::size_t i = 0; i != frames.size(); ++i)
+                compress_one(i);
+        else {
+            // One task per frame, handed out through a shared counter so fast frames do
+            // not leave a worker idle while a slow one finishes.
+            std::atomic<std::size_t> next(0);
+            std::vector<std::thread> pool;
+            pool.reserve(workers);
+            for (std::size_t w = 0; w != workers; ++w)
+                pool.emplace_back([&] {
+                    for (std::size_t i; (i = next.fetch_add(1)) < frames.size(); )
+                        compress_one(i);
+                });
+            for (auto& worker : pool)
+                worker.join();
+        }
+        std::size_t total = f_terse_bytes();
+        for (auto const& stream : streams)
+            total += stream.size();
+        d_terse_data.resize(total);
+        for (std::size_t i = 0; i != streams.size(); ++i) {
+            std::size_t const at = f_terse_bytes(); // the byte offset where frame i starts
+            d_terse_frames.push_back(at);
+            std::memcpy(d_terse_data.data() + at, streams[i].data(), streams[i].size());
+            d_bit_cursor = at * 8 + stream_bits[i];
+            d_prolix_bits = std::max(d_prolix_bits, stream_prolix_bits[i]);
+        }
+    }
+
     /**
      * @brief Adds another frame to the Terse object. The new frame is defined by a reference to a container.
      *
@@ -356,37 +694,24 @@ public:
         std::uint8_t const* terse_begin = f_find_terse_frame(frame);
         if (d_signed)
             assert(std::is_signed_v<typename std::iterator_traits<Iterator>::value_type>);
-        Bit_pointer bitp(terse_begin);
-        uint8_t significant_bits = 0;
-        for (size_t from = 0; from < size(); from += d_block) {
-            if (*bitp++ == 0) {
-                significant_bits = Bit_range<const std::uint8_t*>(bitp,3);
-                bitp += 3;
-                if (significant_bits == 7) {
-                    significant_bits += uint8_t(Bit_range<const std::uint8_t*>(bitp, 2));
-                    bitp += 2;
-                    if (significant_bits == 10) {
-                        significant_bits += uint8_t(Bit_range<const std::uint8_t*>(bitp, 6));
-                        bitp += 6;
-                    }
-                }
-            }
-            if (significant_bits == 0)
-                std::fill(begin + from, begin + std::min(size(), from + d_block), 0);
-            else {
-                Bit_range<const std::uint8_t*> bitr(bitp, significant_bits);
-                if constexpr (std::is_integral<typename std::iterator_traits<Iterator>::value_type>::value)
-                    bitr.get_range(begin + from, begin + std::min(size(), from + d_block));
-                else if (!is_signed())
-                    for (auto i = from, to = std::min(size(), from + d_block); i < to; ++i, bitr.next())
-                        begin[i] = double(std::uint64_t(bitr));
-                else for (auto i = from, to = std::min(size(), from + d_block); i < to; ++i, bitr.next())
-                    begin[i] = double(std::int64_t(bitr));
-                bitp = bitr.begin();
-            }
+        // Pass 1: parse all block headers into dense width/offset arrays. This breaks the
+        // loop-carried bit-pointer dependency, so the payload pass below runs over blocks
+        // of known width and position and can use the vectorized unpackers freely.
+        std::vector<std::uint8_t> widths;
+        std::vector<std::uint64_t> offsets;
+        std::size_t const end_bit = f_decode_headers(terse_begin, widths, offsets);
+        // Dispatch once on the block size so the common sizes run with a compile-time
+        // constant block: the per-iteration std::min() tail check disappears and the
+        // unpackers see fixed trip counts. The bitstream is the same either way.
+        switch (d_block) {
+            case 8:  f_prolix_impl<8> (begin, terse_begin, widths, offsets); break;
+            case 12: f_prolix_impl<12>(begin, terse_begin, widths, offsets); break;
+            case 16: f_prolix_impl<16>(begin, terse_begin, widths, offsets); break;
+            case 32: f_prolix_impl<32>(begin, terse_begin, widths, offsets); break;
+            default: f_prolix_impl<0> (begin, terse_begin, widths, offsets); break;
         }
         if (d_terse_frames.size() > ++frame)
-            d_terse_frames[frame] = 1 + (bitp - Bit_pointer<const std::uint8_t*>(terse_begin)) / 8;
+            d_terse_frames[frame] = std::size_t(terse_begin - d_terse_data.data()) + 1 + end_bit / 8;
     }
     
     /**
@@ -442,7 +767,7 @@ public:
      *
      * @return The number of bytes used for encoding the Terse data.
      */
-    std::size_t const terse_size() const {return d_terse_data.size();}
+    std::size_t const terse_size() const {return f_terse_bytes();}
     
     /**
      * @brief Write the Terse object to the specified output stream.
@@ -453,25 +778,45 @@ public:
      * @param ostream The output stream to which the Terse data will be written.
      */
     void write(std::ostream& ostream) const {
-        // Write Terse object attributes to the output stream
-        ostream << "<Terse prolix_bits=\"" << d_prolix_bits << "\"";
-        ostream << " signed=\"" << d_signed << "\"";
-        ostream << " block=\"" << d_block << "\"";
-        ostream << " memory_size=\"" << d_terse_data.size() * sizeof(std::uint8_t) << "\"";
-        ostream << " number_of_values=\"" << size() << "\"";
-        
+        // Format the XML header locale-free into a single buffer with std::to_chars,
+        // then hand the stream exactly two write calls (header, payload) instead of a
+        // chain of operator<< conversions, each with its own virtual dispatch and
+        // locale handling. Flushing is left to the caller.
+        std::string header;
+        header.reserve(200 + 21 * d_dim.size());
+        auto const append_number = [&header](std::uint64_t value) {
+            char num[20];
+            header.append(num, std::to_chars(num, num + sizeof(num), value).ptr);
+        };
+        auto const append_attribute = [&](char const* name, std::uint64_t value) {
+            header += name;
+            header += '"';
+            append_number(value);
+            header += '"';
+        };
+        header += "<Terse";
+        append_attribute(" prolix_bits=", d_prolix_bits);
+        append_attribute(" signed=", d_signed);
+        append_attribute(" block=", d_block);
+        append_attribute(" memory_size=", f_terse_bytes() * sizeof(std::uint8_t));
+        append_attribute(" number_of_values=", size());
+
         // Write Terse object dimensions if available
         if (!d_dim.empty()) {
-            ostream << " dimensions=\"";
-            for (size_t i = 0; i + 1 != d_dim.size(); ++i)
-                ostream << d_dim[i] << " ";
-            ostream << d_dim.back() << "\"";
+            header += " dimensions=\"";
+            for (size_t i = 0; i + 1 != d_dim.size(); ++i) {
+                append_number(d_dim[i]);
+                header += ' ';
+            }
+            append_number(d_dim.back());
+            header += '"';
         }
-        ostream << " number_of_frames=\"" << d_terse_frames.size() << "\"/>";
-        
-        // Write Terse object data to the output stream
-        ostream.write(reinterpret_cast<const char*>(d_terse_data.data()), d_terse_data.size());
-        ostream.flush();
+        append_attribute(" number_of_frames=", d_terse_frames.size());
+        header += "/>";
+
+        // Write Terse object header and data to the output stream
+        ostream.write(header.data(), header.size());
+        ostream.write(reinterpret_cast<const char*>(d_terse_data.data()), f_terse_bytes());
     }
     
 private:
@@ -480,108 +825,364 @@ private:
     std::size_t d_size;
     unsigned d_prolix_bits = 0;
     std::vector<std::size_t> d_dim;
-    std::vector<std::uint8_t> d_terse_data;
+    std::vector<std::uint8_t, terse_detail::default_init_allocator<std::uint8_t>> d_terse_data;
     std::vector<std::size_t> d_terse_frames;
+    std::size_t d_bit_cursor = 0;
+
+    // Exact number of encoded bytes. d_terse_data may be larger: the scratch capacity of
+    // the last f_compress call is kept across push_back calls instead of being trimmed,
+    // so appending frames does not reallocate and copy the accumulated stream each time.
+    std::size_t const f_terse_bytes() const {return d_bit_cursor == 0 ? 0 : 1 + d_bit_cursor / 8;}
     
+    // Locale-free integer parsing of an XML attribute value; unlike std::stoul and
+    // friends it neither allocates nor consults the global locale.
+    template <typename T0>
+    static T0 f_parse(std::string_view text) noexcept {
+        T0 value{};
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
+
     Terse(std::ifstream& istream, XML_element const& xmle) :
-    d_prolix_bits(unsigned(std::stoul(xmle.attribute("prolix_bits")))),
-    d_signed(std::stoul(xmle.attribute("signed"))),
-    d_block(int(std::stoul(xmle.attribute("block")))),
-    d_size(std::stoull(xmle.attribute("number_of_values"))) {
-        std::string s = xmle.attribute("dimensions");
-        std::istringstream iss(s);
-        unsigned int val;
-        while (iss >> val)
+    d_prolix_bits(f_parse<unsigned>(xmle.attribute("prolix_bits"))),
+    d_signed(f_parse<unsigned>(xmle.attribute("signed")) != 0),
+    d_block(f_parse<unsigned>(xmle.attribute("block"))),
+    d_size(f_parse<std::size_t>(xmle.attribute("number_of_values"))) {
+        std::string const s = xmle.attribute("dimensions");
+        for (char const* p = s.data(), * const end = s.data() + s.size(); p != end; ) {
+            std::size_t val;
+            auto const [next, ec] = std::from_chars(p, end, val);
+            if (ec != std::errc()) {
+                ++p; // skip the separating whitespace
+                continue;
+            }
             d_dim.push_back(val);
-        d_terse_data.resize(std::stold(xmle.attribute("memory_size")));
+            p = next;
+        }
+        d_terse_data.resize(f_parse<std::size_t>(xmle.attribute("memory_size")));
         istream.read((char*)&d_terse_data[0], d_terse_data.size());
-        d_terse_frames.resize(std::stoull(xmle.attribute("number_of_frames")), 0);
+        d_bit_cursor = d_terse_data.empty() ? 0 : (d_terse_data.size() - 1) * 8;
+        d_terse_frames.resize(f_parse<std::size_t>(xmle.attribute("number_of_frames")), 0);
     }
     
+    // Dispatches once on the block size so the common sizes compress with a compile-time
+    // constant block (see f_prolix_impl); the bitstream produced is identical either way.
     template <typename Iterator>
     void const f_compress(Iterator data) {
-        std::size_t prev_data_size = d_terse_data.size();
-        d_terse_data.resize(prev_data_size + std::ceil(d_size * (sizeof(decltype(*data)) + (long double)(12.0) / (d_block * 8)) / sizeof(std::uint8_t)), 0);
-        Bit_pointer bitp (d_terse_data.data() + prev_data_size);
+        switch (d_block) {
+            case 8:  return f_compress_impl<8> (data);
+            case 12: return f_compress_impl<12>(data);
+            case 16: return f_compress_impl<16>(data);
+            case 32: return f_compress_impl<32>(data);
+            default: return f_compress_impl<0> (data);
+        }
+    }
+
+    template <unsigned BLOCK, typename Iterator>
+    void const f_compress_impl(Iterator data) {
+        unsigned const block = BLOCK ? BLOCK : d_block;
+        std::size_t const prev_data_size = f_terse_bytes();
+        // Worst case for one frame: every value stored at full width plus a 12-bit header
+        // per block, with the header bytes rounded up. The + 16 absorbs the header of a
+        // partial tail block, the rounded-up trailing byte of f_terse_bytes(), and leaves
+        // room for word-granular writer stores. Pure integer arithmetic: the previous
+        // long double std::ceil() expression forced x87 code on x86-64 for what is simply
+        // an integer ceiling division.
+        std::size_t const upper_bound = prev_data_size + d_size * sizeof(decltype(*data))
+            + (d_size * 12 + d_block * 8 - 1) / (d_block * 8) + 16;
+        if (d_terse_data.size() < upper_bound)
+            d_terse_data.resize(upper_bound); // deliberately left uninitialized; every byte up to f_terse_bytes() is stored below
+        Bit_writer writer(d_terse_data.data() + prev_data_size);
         int prevbits = 0;
-        for (size_t from = 0; from < d_size; from += d_block) {
-            auto const to = std::min(d_size, from + d_block);
-            typename std::iterator_traits<Iterator>::value_type setbits(0);
-            auto p = data;
-            for (auto i = from; i != to; ++i, ++p)
-                if constexpr (std::is_unsigned_v<decltype(setbits)>)
-                    setbits |= *p;
-                else if constexpr (std::is_signed_v<decltype(setbits)>)
-                    setbits |= std::abs(*p);
-            unsigned significant_bits = f_highest_set_bit(setbits);
-            d_prolix_bits = std::max(d_prolix_bits, significant_bits);
-            if (prevbits == significant_bits) {
-                (*bitp).set();
-                ++bitp;
-            }
-            else {
-                if (significant_bits < 7) {
-                    Bit_range<std::uint8_t*>(++bitp, 3) |= significant_bits;
-                    bitp += 3;
-                }
-                else if (significant_bits < 10) {
-                    Bit_range<std::uint8_t*>(++bitp, 5) |= 0b111 + ((significant_bits - 7) << 3);
-                    bitp += 5;
+        using Value = typename std::iterator_traits<Iterator>::value_type;
+        // One block's worth of values, filled by the same pass that computes setbits;
+        // the payload is emitted from this copy so each input value is loaded only once.
+        constexpr std::size_t buf_capacity = BLOCK ? BLOCK : 64;
+        Value block_buf[buf_capacity];
+        auto const encode_block = [&](std::size_t const count) {
+            unsigned significant_bits;
+            Value const* emit_from = nullptr;
+            if constexpr (std::contiguous_iterator<Iterator> && std::is_integral_v<Value>) {
+                if (count <= buf_capacity) {
+                    auto const setbits = terse_detail::setbits_of_block_copy(std::to_address(data), count, block_buf);
+                    significant_bits = f_highest_set_bit(setbits) + (std::is_signed_v<Value> && setbits != 0 ? 1 : 0);
+                    emit_from = block_buf;
                 }
                 else {
-                    Bit_range<std::uint8_t*>(++bitp, 11) |= 0b11111 + ((significant_bits - 10) << 5);
-                    bitp += 11;
+                    auto const setbits = terse_detail::setbits_of_block(std::to_address(data), count);
+                    significant_bits = f_highest_set_bit(setbits) + (std::is_signed_v<Value> && setbits != 0 ? 1 : 0);
+                }
+            }
+            else {
+                std::make_unsigned_t<Value> setbits(0);
+                auto p = data;
+                for (std::size_t i = 0; i != count; ++i, ++p) {
+                    Value const v = *p;
+                    auto u = std::make_unsigned_t<Value>(v);
+                    if constexpr (std::is_signed_v<Value>) {
+                        // Branchless |v| in the unsigned type, as in setbits_of_block.
+                        auto const s = std::make_unsigned_t<Value>(v >> (sizeof(Value) * 8 - 1));
+                        u = (u ^ s) - s;
+                    }
+                    setbits |= u;
                 }
+                significant_bits = f_highest_set_bit(setbits) + (std::is_signed_v<Value> && setbits != 0 ? 1 : 0);
+            }
+            // A signed block containing INT_MIN saturates |v| at the sign bit, which would
+            // overcount the width by one (and overrun k_header for int64): 8 * sizeof(Value)
+            // bits always suffice, and a full-width block round-trips as two's complement.
+            significant_bits = std::min<unsigned>(significant_bits, 8 * sizeof(Value));
+            d_prolix_bits = std::max(d_prolix_bits, significant_bits);
+            if (prevbits == significant_bits)
+                writer.write(1, 1);
+            else {
+                // The leading 0 bit of a full header rides along as bit 0 of the write.
+                auto const [header_length, header_bits] = k_header[significant_bits];
+                writer.write(std::uint64_t(header_bits) << 1, header_length + 1);
                 prevbits = significant_bits;
             }
             if (significant_bits != 0) {
-                Bit_range<std::uint8_t*> r(bitp, significant_bits);
-                r.append_range(data, data + (to - from));
-                data += (to - from);
-                bitp = r.begin();
+                // Bit_writer::write masks the value to significant_bits. When a signed block
+                // needs the full width of Value, Bit_range used to leak the sign-extension
+                // bits of negative values into the following fields, corrupting the stream;
+                // the masked write encodes such blocks correctly.
+                if (emit_from) {
+                    for (std::size_t i = 0; i != count; ++i)
+                        writer.write(std::uint64_t(std::make_unsigned_t<Value>(emit_from[i])), significant_bits);
+                    data += count;
+                }
+                else
+                    for (std::size_t i = 0; i != count; ++i, ++data)
+                        writer.write(std::uint64_t(std::make_unsigned_t<Value>(*data)), significant_bits);
             }
             else if constexpr (std::is_same_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>)
-                data += d_block;
+                data += count;
             else
-                for (int i = 0; i != d_block; ++i, ++data);
-        }
-        d_terse_data.resize(1 + (bitp - d_terse_data.data()) / (sizeof(std::uint8_t) * 8));
-        d_terse_data.shrink_to_fit();
+                for (std::size_t i = 0; i != count; ++i, ++data);
+        };
+        // Full blocks run with a fixed count; the one possibly-partial tail block is peeled.
+        std::size_t const full = d_size - d_size % block;
+        for (std::size_t from = 0; from != full; from += block)
+            encode_block(block);
+        if (full != d_size)
+            encode_block(d_size - full);
+        d_bit_cursor = prev_data_size * 8 + writer.bits_written();
+        writer.flush();
+        // f_terse_bytes() rounds one byte up when the frame ends exactly on a byte
+        // boundary; with the buffer no longer pre-zeroed, that byte must be stored too.
+        if (d_bit_cursor != 0 && d_bit_cursor % 8 == 0)
+            d_terse_data[d_bit_cursor / 8] = 0;
     }
     
+    // Precomputed block header (length in bits, bit pattern) per significant_bits value,
+    // excluding the leading 0 bit, which is skipped rather than written. Replaces the
+    // three-way branch on significant_bits with a single table lookup and masked OR.
+    static constexpr std::array<std::pair<std::uint8_t, std::uint16_t>, 65> k_header = [] {
+        std::array<std::pair<std::uint8_t, std::uint16_t>, 65> table{};
+        for (int s = 0; s <= 64; ++s) {
+            if (s < 7)
+                table[s] = {3, std::uint16_t(s)};
+            else if (s < 10)
+                table[s] = {5, std::uint16_t(0b111 | ((s - 7) << 3))};
+            else
+                table[s] = {11, std::uint16_t(0b11111 | ((s - 10) << 5))};
+        }
+        return table;
+    }();
+
     template <typename T0>
     constexpr inline int const f_highest_set_bit(T0 val) const noexcept {
-        if constexpr (std::is_signed_v<T0>)
-            return (val == 0) ? 0 : 1 + f_highest_set_bit(std::make_unsigned_t<T0> (abs(val)));
-        else {
-            int r=0;
-            for ( ; val; val>>=1, ++r);
-            return r;
+        if constexpr (std::is_signed_v<T0>) {
+            if (val == 0)
+                return 0;
+            auto u = std::make_unsigned_t<T0>(val);
+            if (val < 0)
+                u = ~u; // a negative value needs the bits of ~val plus the sign bit; also avoids abs(INT_MIN)
+            return 1 + int(std::bit_width(std::uint64_t(u)));
         }
+        else
+            return int(std::bit_width(std::uint64_t(val))); // single lzcnt/bsr instead of a shift loop
     }
     
-    std::uint8_t const* f_find_terse_frame(std::size_t frame) {
-        if (frame > 0 && d_terse_frames[frame] == 0) {
-            std::uint8_t const* terse_begin = f_find_terse_frame(frame - 1);
-            Bit_pointer<const std::uint8_t*> bitp(terse_begin);
-            uint8_t significant_bits = 0;
-            for (size_t from = 0; from < size(); from += d_block) {
-                if (*bitp++ == 0) {
-                    significant_bits = Bit_range<const std::uint8_t*>(bitp,3);
-                    bitp += 3;
-                    if (significant_bits == 7) {
-                        significant_bits += uint8_t(Bit_range<const std::uint8_t*>(bitp, 2));
-                        bitp += 2;
-                        if (significant_bits == 10) {
-                            significant_bits += uint8_t(Bit_range<const std::uint8_t*>(bitp, 6));
-                            bitp += 6;
-                        }
+    // Payload pass of prolix() for one frame, specialized on the block size: BLOCK == 0
+    // is the generic path reading d_block, any other value is a compile-time constant
+    // the optimizer folds into the loop bounds. Full blocks run without a tail check;
+    // the one possibly-partial block at the end is peeled out of the loop.
+    template <unsigned BLOCK, typename Iterator>
+    void f_prolix_impl(Iterator begin, std::uint8_t const* terse_begin,
+                       std::vector<std::uint8_t> const& widths, std::vector<std::uint64_t> const& offsets) {
+        unsigned const block = BLOCK ? BLOCK : d_block;
+        // The unpack kernel for this CPU and output type, resolved once per process and
+        // read once per frame; the per-block loop below carries no CPU feature tests.
+        auto const unpack = terse_detail::unpack_dispatch<typename std::iterator_traits<Iterator>::value_type>::value;
+        std::size_t const full = size() - size() % block; // first index of the partial tail block
+        std::size_t bi = 0;
+        for (std::size_t from = 0; from != full; from += block, ++bi) {
+            if (widths[bi] == 0) {
+                // Coalesce the run of consecutive zero blocks into one wide fill (a single
+                // memset for contiguous output) instead of one small fill per block.
+                std::size_t run_end = from + block;
+                while (run_end != full && widths[bi + 1] == 0) {
+                    run_end += block;
+                    ++bi;
+                }
+                bool filled = false;
+#ifdef JPA_TERSE_X86
+                // For frames larger than L2 the decoded output cannot stay cached anyway,
+                // so clear long zero runs with streaming stores instead of a cached memset.
+                using Value = typename std::iterator_traits<Iterator>::value_type;
+                if constexpr (std::contiguous_iterator<Iterator> && std::is_trivially_copyable_v<Value>) {
+                    if (size() * sizeof(Value) > 512 * 1024) {
+                        terse_detail::stream_zero_bytes(std::to_address(begin + from), (run_end - from) * sizeof(Value));
+                        filled = true;
+                    }
+                }
+#endif
+                if (!filled)
+                    std::fill(begin + from, begin + run_end, 0);
+                from = run_end - block; // the for-header advances by one block
+            }
+            else
+                f_prolix_payload(begin, terse_begin, from, from + block, widths[bi], offsets[bi], unpack);
+        }
+        if (full != size()) {
+            if (widths[bi] == 0)
+                std::fill(begin + full, begin + size(), 0);
+            else
+                f_prolix_payload(begin, terse_begin, full, size(), widths[bi], offsets[bi], unpack);
+        }
+    }
+
+    // Decodes the payload of one block of known width into [begin + from, begin + to).
+    template <typename Iterator>
+    void f_prolix_payload(Iterator begin, std::uint8_t const* terse_begin,
+                          std::size_t from, std::size_t to,
+                          std::uint8_t significant_bits, std::size_t bitpos,
+                          typename terse_detail::unpack_dispatch<typename std::iterator_traits<Iterator>::value_type>::fn const unpack) const {
+        using Value = typename std::iterator_traits<Iterator>::value_type;
+        bool unpacked = false;
+        if constexpr (std::is_integral_v<Value>) {
+            // Fast path: unaligned 64-bit loads, shift and mask per value, instead of a
+            // Bit_range walk. Usable whenever the destination needs no clamping; a field
+            // straddling a 64-bit window (width 58-64 only) picks up its high bits from
+            // the following word. Only narrowing decodes fall through to Bit_range.
+            if (significant_bits <= sizeof(Value) * 8) {
+                std::uint8_t const* const stream_end = d_terse_data.data() + d_terse_data.size();
+                auto i0 = from;
+                if constexpr (std::contiguous_iterator<Iterator>
+                              && (sizeof(Value) == 2 || sizeof(Value) == 4)) {
+                    if (significant_bits <= 16) {
+                        std::size_t const done = unpack(
+                            terse_begin, bitpos, int(significant_bits), std::to_address(begin + from),
+                            to - from, stream_end);
+                        i0 += done;
+                        bitpos += done * significant_bits;
                     }
                 }
-                bitp += significant_bits * d_block;
+                if (i0 != to) {
+                    std::uint64_t const mask = significant_bits == 64
+                        ? ~std::uint64_t(0) : (std::uint64_t(1) << significant_bits) - 1;
+                    int const extend = 64 - significant_bits;
+                    // Each value is read through a window of up to 16 bytes from its first
+                    // byte. The final block of a frame routinely ends within that distance
+                    // of the stream's end, so values starting in the last bytes are read
+                    // from a zero-padded copy instead of loading past d_terse_data.
+                    std::uint8_t padded[32];
+                    std::uint8_t const* guard = stream_end;
+                    if (terse_begin + ((bitpos + (to - i0 - 1) * significant_bits) >> 3) + 16 > stream_end) {
+                        guard = stream_end - terse_begin >= 16 ? stream_end - 16 : terse_begin;
+                        std::memset(padded, 0, sizeof(padded));
+                        std::memcpy(padded, guard, std::size_t(stream_end - guard));
+                    }
+                    for (auto i = i0; i != to; ++i, bitpos += significant_bits) {
+                        std::uint8_t const* p = terse_begin + (bitpos >> 3);
+                        if (p >= guard)
+                            p = padded + (p - guard);
+                        unsigned const shift = unsigned(bitpos & 7);
+                        std::uint64_t v = read64le(p) >> shift;
+                        if (shift + significant_bits > 64) // the field spills into the next word
+                            v |= read64le(p + 8) << (64 - shift);
+                        if constexpr (std::is_signed_v<Value>)
+                            begin[i] = Value(std::int64_t((v & mask) << extend) >> extend);
+                        else
+                            begin[i] = Value(v & mask);
+                    }
+                }
+                unpacked = true;
+            }
+        }
+        if (!unpacked) {
+            Bit_range<const std::uint8_t*> bitr(Bit_pointer<const std::uint8_t*>(terse_begin, std::ptrdiff_t(bitpos)), significant_bits);
+            if constexpr (std::is_integral<Value>::value)
+                bitr.get_range(begin + from, begin + to);
+            else if (!is_signed())
+                for (auto i = from; i < to; ++i, bitr.next())
+                    begin[i] = double(std::uint64_t(bitr));
+            else for (auto i = from; i < to; ++i, bitr.next())
+                begin[i] = double(std::int64_t(bitr));
+        }
+    }
+
+    // Parses the block headers of one frame into dense per-block arrays (SoA layout):
+    // widths[b] is the payload width of block b, offsets[b] the bit offset of its payload
+    // relative to terse_begin. Returns the bit offset one past the frame's last payload.
+    std::size_t f_decode_headers(std::uint8_t const* terse_begin,
+                                 std::vector<std::uint8_t>& widths, std::vector<std::uint64_t>& offsets) const {
+        std::size_t const blocks = (size() + d_block - 1) / d_block;
+        widths.reserve(blocks);
+        offsets.reserve(blocks);
+        Bit_reader reader(terse_begin, d_terse_data.data() + d_terse_data.size());
+        uint8_t significant_bits = 0;
+        for (size_t from = 0; from < size(); from += d_block) {
+            if (reader.read(1) == 0) {
+                significant_bits = uint8_t(reader.read(3));
+                if (significant_bits == 7) {
+                    significant_bits += uint8_t(reader.read(2));
+                    if (significant_bits == 10)
+                        significant_bits += uint8_t(reader.read(6));
+                }
             }
-            d_terse_frames[frame] = 1 + (bitp - Bit_pointer<const std::uint8_t*>(terse_begin)) / 8;
+            widths.push_back(significant_bits);
+            offsets.push_back(reader.bit_position());
+            reader.skip(significant_bits * (std::min(size(), from + d_block) - from));
         }
+        return reader.bit_position();
+    }
+
+    // Walks one frame's block headers, skipping the payloads, and returns the frame's
+    // bitstream length in bits.
+    std::size_t f_frame_bit_length(std::uint8_t const* terse_begin) const {
+        Bit_reader reader(terse_begin, d_terse_data.data() + d_terse_data.size());
+        uint8_t significant_bits = 0;
+        for (size_t from = 0; from < size(); from += d_block) {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(terse_begin + reader.bit_position() / 8 + 512, 0, 0);
+#endif
+            if (reader.read(1) == 0) {
+                significant_bits = uint8_t(reader.read(3));
+                if (significant_bits == 7) {
+                    significant_bits += uint8_t(reader.read(2));
+                    if (significant_bits == 10)
+                        significant_bits += uint8_t(reader.read(6));
+                }
+            }
+            reader.skip(significant_bits * (std::min(size(), from + d_block) - from));
+        }
+        return reader.bit_position();
+    }
+
+    // Byte offset of a frame's bitstream within d_terse_data. Offsets are computed once
+    // and cached: the scan resumes from the last frame whose offset is already known and
+    // caches every frame it passes, so repeated random frame access costs a single walk
+    // over the whole stream instead of re-scanning all previous frames per call. Also
+    // accounts for a partial final block, which the previous version skipped as a full one.
+    std::uint8_t const* f_find_terse_frame(std::size_t frame) {
+        std::size_t known = frame;
+        while (known > 0 && d_terse_frames[known] == 0)
+            --known;
+        for (; known < frame; ++known)
+            d_terse_frames[known + 1] = d_terse_frames[known]
+                + 1 + f_frame_bit_length(d_terse_data.data() + d_terse_frames[known]) / 8;
         return d_terse_data.data() + d_terse_frames[frame];
     }
 };